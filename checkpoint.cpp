@@ -0,0 +1,183 @@
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <iterator>
+
+#include "checkpoint.hpp"
+#include "options.hpp"
+
+namespace filehasher {
+
+static const char *checkpoint_header = "filehasher checkpoint 2";
+
+checkpoint::checkpoint(std::string path, std::string fingerprint, size_t first_chunk)
+    : path(std::move(path)), fingerprint(std::move(fingerprint)), next(first_chunk), saved(std::chrono::steady_clock::now())
+{
+    log_path = this->path + ".results";
+}
+
+void checkpoint::load() {
+    std::ifstream ifile(path);
+    if(!ifile)
+        throw error("failed to open checkpoint [" + path + "]");
+
+    std::string line;
+    if(!std::getline(ifile, line) || line != checkpoint_header)
+        throw error("invalid checkpoint [" + path + "]");
+
+    std::string key;
+    bool matched = false;
+    while (ifile >> key) {
+        if(key == "fingerprint") {
+            ifile.ignore(1);
+            std::getline(ifile, line);
+            matched = (line == fingerprint);
+        } else if (key == "next") {
+            ifile >> next;
+        } else if (key == "output") {
+            ifile >> written;
+        } else if (key == "done") {
+            size_t first, last;
+            if(ifile >> first >> last) ahead[first] = last;
+        } else if (key == "results") {
+            ifile >> logged;
+            kept_size = logged;
+        } else {
+            throw error("invalid checkpoint [" + path + "]");
+        }
+    }
+    if(!ifile.eof())
+        throw error("invalid checkpoint [" + path + "]");
+    if(!matched)
+        throw error("checkpoint [" + path + "] does not match options or input file");
+}
+
+// Entries written after the last stored progress are dropped (they will be calculated again).
+void checkpoint::restore(const std::function<void(size_t, std::string)>& func) {
+    if(logged == 0)
+        return;
+
+    std::ifstream ifile(log_path);
+    if(!ifile)
+        throw error("failed to open results log [" + log_path + "]");
+
+    std::string line;
+    for (uint64_t pos = 0; pos < logged && std::getline(ifile, line); pos += line.size() + 1) {
+        std::istringstream entry(line);
+        size_t chunk;
+        std::string hash;
+        if(!(entry >> chunk) || !entry.ignore(1) || !std::getline(entry, hash))
+            throw error("invalid results log [" + log_path + "]");
+        func(chunk, std::move(hash));
+    }
+    ifile.close();
+
+    std::error_code ec;
+    std::filesystem::resize_file(log_path, logged, ec);
+    if(ec)
+        throw error("failed to truncate results log [" + log_path + "]: " + ec.message());
+}
+
+void checkpoint::save(uint64_t output_size) {
+    written = output_size;
+    if(log.is_open()) {
+        if(!log.flush())
+            throw error("failed to write results log [" + log_path + "]");
+        logged = kept_size;
+    }
+
+    auto tmp = path + ".tmp";
+    {
+        std::ofstream ofile(tmp, std::ofstream::trunc);
+        ofile << checkpoint_header << '\n';
+        ofile << "fingerprint " << fingerprint << '\n';
+        ofile << "next " << next << '\n';
+        ofile << "output " << written << '\n';
+        for (auto&& [first, last] : ahead)
+            ofile << "done " << first << ' ' << last << '\n';
+        ofile << "results " << logged << '\n';
+        if(!ofile.flush())
+            throw error("failed to write checkpoint [" + tmp + "]");
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if(ec)
+        throw error("failed to write checkpoint [" + path + "]: " + ec.message());
+    saved = std::chrono::steady_clock::now();
+}
+
+void checkpoint::remove() {
+    log.close();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(log_path, ec);
+}
+
+bool checkpoint::save_due() const {
+    return std::chrono::steady_clock::now() - saved >= checkpoint_interval;
+}
+
+bool checkpoint::is_done(size_t chunk) const {
+    if(chunk < next)
+        return true;
+    auto it = ahead.upper_bound(chunk);
+    return it != ahead.begin() && std::prev(it)->second >= chunk;
+}
+
+// Adjacent completed chunks are merged into ranges - so only a few ranges (about one per job in flight) are tracked.
+void checkpoint::complete(size_t chunk) {
+    if(chunk == next) {
+        ++next;
+        if(!ahead.empty() && ahead.begin()->first == next) {
+            next = ahead.begin()->second + 1;
+            ahead.erase(ahead.begin());
+        }
+        return;
+    }
+
+    auto after = ahead.upper_bound(chunk);
+    bool joins_after = after != ahead.end() && after->first == chunk + 1;
+    if(after != ahead.begin() && std::prev(after)->second + 1 == chunk) {
+        auto before = std::prev(after);
+        before->second = joins_after ? after->second : chunk;
+        if(joins_after) ahead.erase(after);
+    } else if(joins_after) {
+        size_t last = after->second;
+        ahead.erase(after);
+        ahead.emplace(chunk, last);
+    } else {
+        ahead.emplace(chunk, chunk);
+    }
+}
+
+// Results log is appended on resume (it is already truncated to stored size) and started over otherwise.
+void checkpoint::keep(size_t chunk, const std::string& hash) {
+    if(!log.is_open()) {
+        log.open(log_path, logged > 0 ? std::ofstream::app : std::ofstream::trunc);
+        if(!log)
+            throw error("failed to open results log [" + log_path + "]");
+    }
+
+    auto entry = std::to_string(chunk) + ' ' + hash + '\n';
+    log << entry;
+    if(!log)
+        throw error("failed to write results log [" + log_path + "]");
+    kept_size += entry.size();
+}
+
+std::string MakeFingerprint(const Options& opts) {
+    std::error_code ec;
+    std::ostringstream res;
+    res << std::filesystem::absolute(opts.InputFile, ec).string()
+        << '|' << std::filesystem::file_size(opts.InputFile, ec)
+        << '|' << std::filesystem::last_write_time(opts.InputFile, ec).time_since_epoch().count()
+        << '|' << opts.BlockSize << '|' << opts.Offset << '|' << opts.Length << '|' << opts.FirstChunk
+        << '|' << (opts.Sorted ? "ordered" : "unordered");
+    for (auto type : opts.Algorithms)
+        res << '|' << to_string(type);
+    return res.str();
+}
+
+}//namespace filehasher
@@ -0,0 +1,69 @@
+#ifndef FILEHASHER_CHECKPOINT_HPP
+#define FILEHASHER_CHECKPOINT_HPP
+
+#include <string>
+#include <map>
+#include <fstream>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+#include <cstdint>
+
+#include "commondefs.hpp"
+
+namespace filehasher {
+
+class Options;
+
+// Tracks completed chunks and periodically stores progress to the checkpoint file.
+// Stored progress contains:
+//  - fingerprint of options and input file (resume is allowed only with the same one);
+//  - first not completed chunk (all chunks before it are completed);
+//  - completed ranges of chunks after it (workers complete jobs out of order, each job is a range of consecutive chunks);
+//  - size of results log stored with progress (only for ordered output);
+//  - size of output written before progress was stored (output should be truncated to it on resume).
+// Checkpoint file is small and rewritten atomically (write temporary file and rename).
+// Ordered results are not written to output until the end - so they are appended to results log ("<path>.results")
+// instead of being kept in memory twice or rewritten on each save. Entries after stored log size are dropped on resume.
+//
+// WARNING: "checkpoint" itlef is not thread-safe (should be used by results writer only)
+class checkpoint {
+public:
+    checkpoint(std::string path, std::string fingerprint, size_t first_chunk);
+
+    // Loads progress from checkpoint file. Fails if fingerprint does not match.
+    void load();
+    // Passes results stored in results log (by loaded progress) to provided function.
+    void restore(const std::function<void(size_t, std::string)>& func);
+    void save(uint64_t output_size);
+    void remove();
+
+    // Returns true if it is time to store progress (see checkpoint_interval).
+    bool save_due() const;
+
+    bool is_done(size_t chunk) const;
+    void complete(size_t chunk);
+    void keep(size_t chunk, const std::string& hash);
+
+    size_t next_chunk() const { return next; }
+    uint64_t output_size() const { return written; }
+
+private:
+    std::string                             path;
+    std::string                             fingerprint;
+    size_t                                  next;
+    uint64_t                                written {0};
+    std::map<size_t, size_t>                ahead;  // first -> last chunk of completed range
+    std::string                             log_path;
+    std::ofstream                           log;
+    uint64_t                                logged {0};
+    uint64_t                                kept_size {0};
+    std::chrono::steady_clock::time_point   saved;
+};
+
+// Generates fingerprint of options (and input file) that affects results.
+std::string MakeFingerprint(const Options& opts);
+
+}//namespace filehasher
+
+#endif//FILEHASHER_CHECKPOINT_HPP
@@ -1,37 +1,58 @@
 #ifndef FILEHASHER_COMMONDEFS_HPP
 #define FILEHASHER_COMMONDEFS_HPP
 
+#include <chrono>
+
 namespace filehasher {
 
 struct error : public std::logic_error {
     explicit error(const std::string& what) : std::logic_error(what) {}
 };
 
-// Dummy limit for result set...
-// In some cases (when we process 10GB file by 2B chunks for example) - several million hashes can be produced.
-// To provide ordered results - we need to store all results in memmory
-// This cam be fixed with "external" sorting implementation. But it will involeves more I/O operations
-/// TODO: Implement external sorting (or find one);
-inline const size_t results_limit       = 100000;
-
 // Dummy limit for queue of chanks to be processed...
 // It will unlikely affect perfomance - optimal number of parralel computations = H/W threaded supported.
 // This limit overlaps this value - so workers will not spend too many time waiting for job
 // But in also help to avoid rnning memmory out.
 inline const size_t queue_limit         = 1000;
 
-// This limit will be used to adjust queue size when large blocks will be requested.
-// Programm will try to determine queue size to fit all blocks waiting to be processed in to the limit.
-// If requested block is large then this limit - synchronous sequetila processing will be done.
-// So, one block will be calculated synchronously using chanks equal to this size.
-// When using "mapping" aproach - this limit is ignored.
+// Default memory budget (can be changed with `--memory` option).
+// Chunk buffers, mapped windows and results of all pipeline stages are accounted in it.
+// Stages reading chunks will wait when the budget is exhausted.
+// Programm will also try to determine queue size to fit all blocks waiting to be processed in to the limit.
+// If requested block is large then half of this limit - synchronous sequetila processing will be done.
+// So, one block will be calculated synchronously using chanks equal to sync_buffer_size.
+//
+// To provide ordered results - we need to store all results in memmory (several million hashes can be produced).
+// Ordered results can use only half of the budget (rest is left for pipeline), processing fails if it is exceeded.
+// This cam be fixed with "external" sorting implementation. But it will involeves more I/O operations
+/// TODO: Implement external sorting (or find one);
 inline const size_t soft_memmory_limit  = 1024 * 1024 * 1024; // 1GB
 
+// Size of file region mapped at once in "mapping" mode.
+// Region is unmapped (and released from memory budget) when all its chunks are processed.
+inline const size_t mapping_window_size = 1024 * 1024 * 64; // 64MB
+
+// Target size of one job passed to workers pool.
+// When small blocks are requested - several consecutive chunks will be packed in one job to fit this size.
+// It helps to avoid chanel push/pop overhead for each chunk (that is far larger than hashing of tiny blocks).
+inline const size_t batch_target_size = 1024 * 1024; // 1MB
+
 // Buffer size that will be used if hash calculation process will fallback to synchronous mode.
-// This can happens when requested block size is  greater then soft_memmory_limit / 2 .
+// This can happens when requested block size is  greater then memory budget / 2 .
 // Or when only one block should be calculated.
 inline const size_t sync_buffer_size  = 1024 * 1024 * 10; // 10MB
 
+// Alignment of ranges evicted from page cache (with `--cache-policy drop`).
+// OS skips partially covered pages and large folios (up to 2MB) - so only aligned pieces of processed range are dropped.
+inline const size_t cache_drop_alignment = 1024 * 1024 * 2; // 2MB
+
+// Followed file is finished when writer closed it and did not reopen (or append) it during this period.
+// Many writers (shell `>>`, scripts, loggers) open and close file for each append - so close itself is not the end.
+inline const std::chrono::seconds follow_close_delay{2};
+
+// How often progress will be stored to checkpoint file (if requested).
+inline const std::chrono::seconds checkpoint_interval{10};
+
 }//namespace filehasher
 
 #endif//FILEHASHER_COMMONDEFS_HPP
\ No newline at end of file
@@ -1,67 +1,116 @@
 #include <string>
-#include <boost/crc.hpp>
-#include <boost/format.hpp>
+#include <cstdint>
+#include <algorithm>
 
 #include "hasher.hpp"
 
 namespace filehasher {
 
-// Base struct for hasher implementaions.
-// To add new algo: derive from this struct and select implementation dureing 'hasher' construction
-struct hasher::hasher_impl
-{
-    friend struct hasher_crc16;
-    virtual ~hasher_impl() {}
+// Size of data slice passed to each hasher of the set in turn.
+// Should fit L1 cache to be read from memory only once.
+static const size_t hasher_set_slice = 16 * 1024;
 
-    virtual void process_bytes(const void *bytes, size_t size) = 0;
-    virtual std::string result() = 0;
+// Formats checksum as upper case hex string with all leading zeros.
+// Implemented without Boost.Format (or streams) - it is called once per chunk and dominates for tiny blocks.
+template<class T>
+static std::string to_hex(T value) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string res(sizeof(T) * 2, '0');
+    for (auto it = res.rbegin(); it != res.rend(); ++it, value >>= 4)
+        *it = digits[value & 0x0F];
+    return res;
+}
+
+std::string to_string(hash_types type) {
+    switch (type) {
+    case hash_types::crc_16:
+        return "crc16";
+    case hash_types::crc_32:
+        return "crc32";
+    case hash_types::sha_1:
+        return "sha1";
+    case hash_types::sha_256:
+        return "sha256";
+    }
+    return "unknown";
+}
 
-    //used to support copy/assign operations with main "hasher" class.
-    virtual std::unique_ptr<hasher_impl> clone() const = 0;
-};
+std::string hasher_crc16::result() {
+    auto res = to_hex(static_cast<std::uint16_t>(crc.checksum()));
+    crc.reset();
+    return res;
+}
+
+std::string hasher_crc32::result() {
+    auto res = to_hex(static_cast<std::uint32_t>(crc.checksum()));
+    crc.reset();
+    return res;
+}
 
-// CRC16 based on Boost.CRC implementation
-struct hasher_crc16 : public hasher::hasher_impl
-{
-    boost::crc_16_type crc;
+// Digest is an array of words (or bytes in newer Boost versions) - `to_hex` formats both in the right order.
+std::string hasher_sha1::result() {
+    boost::uuids::detail::sha1::digest_type digest;
+    sha.get_digest(digest);
+    sha.reset();
 
-    void process_bytes(const void *bytes, size_t size) override {
-        crc.process_bytes(bytes, size);
-    }
-    virtual std::string result() override {
-        auto res = (boost::format("%04X") % crc.checksum()).str();
-        crc.reset();
-        return std::move(res);
+    std::string res;
+    for (auto part : digest)
+        res += to_hex(part);
+    return res;
+}
+
+void hasher_set::process_bytes(const void *bytes, size_t size) {
+    for (size_t offset = 0; offset < size; offset += hasher_set_slice) {
+        const void *slice = static_cast<const char*>(bytes) + offset;
+        size_t slice_size = std::min(hasher_set_slice, size - offset);
+        for (auto&& h : hashers)
+            std::visit([slice, slice_size](auto& concrete) { concrete.process_bytes(slice, slice_size); }, h);
     }
-    virtual std::unique_ptr<hasher_impl> clone() const override {
-        return std::make_unique<hasher_crc16>(*this);
-    };
-};
-
-// Only crc16 is currently implemented
-hasher::hasher(hash_types) : imp(std::make_unique<hasher_crc16>())
-{}
-
-void hasher::process_bytes(const void *bytes, size_t size) {
-    if (bytes != nullptr && size != 0)
-        imp->process_bytes(bytes, size);
 }
 
-std::string hasher::result(){
-    return imp->result();
+std::string hasher_set::result() {
+    std::string res;
+    for (auto&& h : hashers) {
+        if (!res.empty()) res += ' ';
+        res += std::visit([](auto& concrete) { return concrete.result(); }, h);
+    }
+    return res;
 }
 
-hasher::hasher(const hasher& rhs) : imp(rhs.imp->clone())
-{}
+std::string hasher_sha256::result() {
+    sha256::digest_type digest;
+    sha.get_digest(digest);
+    sha.reset();
+
+    std::string res;
+    for (auto part : digest)
+        res += to_hex(part);
+    return res;
+}
 
-hasher& hasher::operator=(const hasher& rhs) {
-    if(!(&rhs == this))
-        imp = rhs.imp->clone();
-    return *this;
+static single_hasher make_single_hasher(hash_types type) {
+    switch (type) {
+    case hash_types::crc_32:
+        return hasher_crc32{};
+    case hash_types::sha_1:
+        return hasher_sha1{};
+    case hash_types::sha_256:
+        return hasher_sha256{};
+    case hash_types::crc_16:
+    default:
+        return hasher_crc16{};
+    }
 }
 
-hasher::hasher(hasher&& lhs) noexcept = default;
-hasher& hasher::operator=(hasher&& lhs) noexcept = default;
-hasher::~hasher() = default;
+// Single algorithm is used directly (without set) - to keep its processing fully specialized.
+hasher make_hasher(const std::vector<hash_types>& types) {
+    if (types.size() == 1)
+        return std::visit([](auto&& concrete) -> hasher { return concrete; }, make_single_hasher(types.front()));
+
+    std::vector<single_hasher> hashers;
+    for (auto type : types)
+        hashers.push_back(make_single_hasher(type));
+    return hasher_set{std::move(hashers)};
+}
 
 }//namespace filehasher
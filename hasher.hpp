@@ -2,32 +2,101 @@
 #define FILEHASHER_HASHER_HPP
 
 #include <string>
-#include <memory>
+#include <vector>
+#include <variant>
+#include <boost/crc.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+
+#include "sha256.hpp"
 
 namespace filehasher {
 
-// Implements hashing algorithm
-// Only CRC16 currently implemented. Implementation is used Boost.CRC library
-// Implementation detailes are hided using `pimpl`
-class hasher {
+// Implements hashing algorithms.
+// CRC16, CRC32, SHA1 and SHA256 are implemented. Implementation is used Boost.CRC and Boost.UUID (sha1) libraries
+// and own SHA256 (the only collision resistant one - CRCs and SHA1 should not be used to detect malicious changes).
+// Each algorithm is a concrete (non virtual) type, so workers templated on it can inline per-chunk processing.
+// To add new algo: implement type with `process_bytes`/`result`, add it to `single_hasher` and `hasher` variants and name it in `to_string`.
+enum class hash_types {crc_16, crc_32, sha_1, sha_256};
+
+inline const hash_types all_hash_types[] = {hash_types::crc_16, hash_types::crc_32, hash_types::sha_1, hash_types::sha_256};
+
+std::string to_string(hash_types type);
+
+// CRC16 based on Boost.CRC implementation
+class hasher_crc16 {
 public:
-    enum class hash_types {crc_16};
+    void process_bytes(const void *bytes, size_t size) {
+        if (bytes != nullptr && size != 0)
+            crc.process_bytes(bytes, size);
+    }
+    std::string result();
 
-    explicit hasher(hash_types);
-    void process_bytes(const void *bytes, size_t size);
+private:
+    boost::crc_16_type crc;
+};
+
+// CRC32 based on Boost.CRC implementation
+class hasher_crc32 {
+public:
+    void process_bytes(const void *bytes, size_t size) {
+        if (bytes != nullptr && size != 0)
+            crc.process_bytes(bytes, size);
+    }
+    std::string result();
+
+private:
+    boost::crc_32_type crc;
+};
+
+// SHA1 based on Boost.UUID implementation
+class hasher_sha1 {
+public:
+    void process_bytes(const void *bytes, size_t size) {
+        if (bytes != nullptr && size != 0)
+            sha.process_bytes(bytes, size);
+    }
     std::string result();
 
-    hasher(const hasher& lhs);
-    hasher& operator = (const hasher& lhs);
-    hasher(hasher&& lhs) noexcept;
-    hasher& operator=(hasher&& lhs) noexcept;
-    ~hasher();
+private:
+    boost::uuids::detail::sha1 sha;
+};
+
+// SHA256 based on own implementation (see sha256.hpp)
+class hasher_sha256 {
+public:
+    void process_bytes(const void *bytes, size_t size) {
+        if (bytes != nullptr && size != 0)
+            sha.process_bytes(bytes, size);
+    }
+    std::string result();
+
+private:
+    sha256 sha;
+};
+
+using single_hasher = std::variant<hasher_crc16, hasher_crc32, hasher_sha1, hasher_sha256>;
+
+// Calculates several digests of the same data with one read pass.
+// Data is passed to all hashers by slices (hasher_set_slice) - so each slice is still in CPU cache for the next hasher.
+// Result contains all digests separated by space (in the order they were requested).
+class hasher_set {
+public:
+    explicit hasher_set(std::vector<single_hasher> hashers) : hashers(std::move(hashers))
+    {}
+
+    void process_bytes(const void *bytes, size_t size);
+    std::string result();
 
-    struct hasher_impl;
 private:
-    std::unique_ptr<hasher_impl> imp;
+    std::vector<single_hasher> hashers;
 };
 
+// Holds one of supported algorithms (or set of them).
+// Should be dispatched once (with `std::visit`) to select specialized processing pipeline.
+using hasher = std::variant<hasher_crc16, hasher_crc32, hasher_sha1, hasher_sha256, hasher_set>;
+
+hasher make_hasher(const std::vector<hash_types>& types);
+
 }//namespce filehasher
 
-#endif//FILEHASHER_HASHER_HPP
\ No newline at end of file
+#endif//FILEHASHER_HASHER_HPP
@@ -2,12 +2,19 @@
 #include <fstream>
 #include <chrono>
 #include <set>
-#include <memory_resource>
+#include <optional>
+#include <filesystem>
+#include <memory>
+#include <map>
+#include <atomic>
+#include <cstring>
 #include <boost/interprocess/managed_mapped_file.hpp>
 
 #include "commondefs.hpp"
 #include "options.hpp"
 #include "threading.hpp"
+#include "reader.hpp"
+#include "checkpoint.hpp"
 
 using namespace filehasher;
 
@@ -34,12 +41,77 @@ namespace std {
 //  - process oredered results (accumulate, sort, write at the and).
 using resulter_function_t = std::function<void(result_t&& r)>;
 
+// Packed results of one job (batch of consecutive chunks).
+using results_t = std::vector<result_t>;
+
+// Estimates memory used by one result (with its hash) stored in a container.
+inline size_t result_size(const result_t& r) {
+    return sizeof(result_t) + (r.hash.capacity() > 15 ? r.hash.capacity() : 0);
+}
+
+// Estimates memory used by one result stored in ordered container (tree node overhead included).
+inline size_t ordered_result_size(const result_t& r) {
+    return result_size(r) + 4 * sizeof(void*);
+}
+
+// Results of one job passed from workers to results writer.
+// Accounted in memory budget without blocking (results of already read chunks should be passed anyway).
+struct results_batch_t {
+    results_t       results;
+    memory_lease    lease;
+
+    results_batch_t() = default;
+    results_batch_t(memory_budget& budget, results_t&& res) : results(std::move(res)) {
+        size_t size = 0;
+        for (auto&& r : results) size += result_size(r);
+        lease = budget.charge(size);
+    }
+};
+
+// Calculates hashes for batch of consecutive chunks placed in one contiguous buffer.
+// The last chunk in batch can be shorter than block size.
+template<class Hasher>
+static results_t hash_batch(Hasher& hash, const char *data, size_t size, size_t block_size, size_t first_chunk) {
+    results_t results;
+    results.reserve(size / block_size + 1);
+    for (size_t offset = 0; offset < size; offset += block_size) {
+        hash.process_bytes(data + offset, std::min(block_size, size - offset));
+        results.push_back(result_t{first_chunk++, hash.result()});
+    }
+    return results;
+}
+
+
+// Runs producer `void(size_t first, size_t step)` on several reader threads (on current thread if only one reader requested).
+// Each reader gets its own `first` and the same `step` (number of readers).
+// If any reader fails - input chanel is closed (to stop others) and exception is rethrown.
+template<class C, class P>
+static void run_readers(size_t nreaders, C& input, P& producer) {
+    if (nreaders <= 1) {
+        producer(0, 1);
+        return;
+    }
+
+    thread_group readers;
+    for (size_t r = 0; r < nreaders; r++) {
+        readers.launch([&producer, &input, r, nreaders] {
+            try {
+                producer(r, nreaders);
+            } catch (...) {
+                input->close();
+                throw;
+            }
+        });
+    }
+    readers.join();
+}
 
 // Do the work in synchronous mode
-// This can happens when requested block size is  greater then soft_memmory_limit / 2 .
+// This can happens when requested block size is  greater then memory budget / 2 .
 // Or when only one block should be calculated in streaming mode.
-static void do_with_sync(Options opts, hasher hash, const resulter_function_t& rfunc) {
-    size_t block_num = 0;
+template<class Hasher>
+static void do_with_sync(Options opts, Hasher hash, memory_budget& budget, const resulter_function_t& rfunc) {
+    size_t block_num = opts.FirstChunk;
     size_t remainder = opts.BlockSize;
     auto processor = [&] (const void *data, size_t size) {
         while (size != 0 && data != nullptr) {
@@ -56,19 +128,26 @@ static void do_with_sync(Options opts, hasher hash, const resulter_function_t& r
         }
     };
 
-    std::ifstream ifile(opts.InputFile, std::ifstream::binary);
-    if(!ifile)
-        throw error("failed to open file [" + opts.InputFile + "]");
+    file_reader ifile(opts.InputFile);
+    std::optional<cache_dropper> dropper;
+    if(opts.Cache == CachePolicy::drop)
+        dropper.emplace(opts.InputFile, opts.Offset);
 
-    std::vector<char> buff(sync_buffer_size);
-    for (size_t i=0; ifile; i++) {
-        ifile.read(buff.data(), buff.size());
+    auto lease = budget.charge(std::min(sync_buffer_size, budget.get_limit()));
+    std::vector<char> buff(lease.get_size());
+    for (uint64_t pos = 0; pos < opts.Length;) {
+        size_t to_read = std::min<uint64_t>(buff.size(), opts.Length - pos);
+        size_t readed = ifile.read_at(buff.data(), to_read, opts.Offset + pos);
+        if(readed != to_read) throw error("failed to read input file");
 
-        size_t readed = ifile.gcount();
-        if(readed != sync_buffer_size && !ifile.eof()) throw error("failed to read input file");
-        if(readed == 0) break;
+        // Data is copied to the buffer - so cached pages are not needed anymore.
+        if(dropper)
+            dropper->release(opts.Offset + pos, readed);
+        if(pos + readed < opts.Length)
+            ifile.prefetch(opts.Offset + pos + readed, std::min<uint64_t>(buff.size(), opts.Length - pos - readed));
 
         processor(buff.data(), readed);
+        pos += readed;
     }
 
     //Las (partially) calculated block
@@ -78,23 +157,32 @@ static void do_with_sync(Options opts, hasher hash, const resulter_function_t& r
 }
 
 // Do the work using stream reading from input file.
-// Producer (main thread) will reads chunks one by one and put them to the input chanel of workers pool.
-// Max memmory usage is limeted with Options.QueueSize.
-static void do_with_streaming(Options opts, hasher hash, const resulter_function_t& rfunc) {
+// Producer (main thread) will reads batches of Options.BatchSize chunks and put them to the input chanel of workers pool.
+// If several Options.Readers requested - each one will read its own batches (every Options.Readers-th one) in separate thread.
+// If Options.Follow requested - producer will wait for new blocks of growing file.
+// Max memmory usage is limeted with memory budget (and Options.QueueSize).
+template<class Hasher>
+static void do_with_streaming(Options opts, Hasher hash, memory_budget& budget, const resulter_function_t& rfunc) {
+    // Jobs and results are taken by value by workers - so their memory is released as soon as they are processed.
     struct job_t {
         size_t                  chunk_number{0};
-        std::pmr::vector<char>  chank;
+        std::vector<char>       chank;
+        memory_lease            lease;
     };
 
-    piped_workers_pool<job_t, result_t>
-    workers (opts.Workers, opts.QueueSize, [hash](job_t&& job) mutable {
-        hash.process_bytes(job.chank.data(), job.chank.size());
-        return result_t{job.chunk_number, hash.result()};
+    // Job buffers are allocated from default resource (not pooled): freed buffers should go back to allocator
+    // so resident memory stays within the memory budget.
+    const size_t job_size = opts.BlockSize * opts.BatchSize;
+
+    piped_workers_pool<job_t, results_batch_t>
+    workers (opts.Workers, opts.QueueSize, [hash, bsize = opts.BlockSize, &budget](job_t job) mutable {
+        auto results = hash_batch(hash, job.chank.data(), job.chank.size(), bsize, job.chunk_number);
+        return results_batch_t{budget, std::move(results)};
     });
     
-    piped_workers_pool<result_t>
-    resulter (1, opts.QueueSize, workers, [&rfunc](result_t&& result) {
-        rfunc(std::move(result));
+    piped_workers_pool<results_batch_t>
+    resulter (1, opts.QueueSize, workers, [&rfunc](results_batch_t batch) {
+        for (auto&& r : batch.results) rfunc(std::move(r));
     });
 
     // input - entry point to the pipe of worker pools.
@@ -104,26 +192,96 @@ static void do_with_streaming(Options opts, hasher hash, const resulter_function
     // terminator - is the last chanel in the pipe.
     // If it is closed before all the job is done - something wrong happend. Producer should break and "wait" waorkers to get exception.
     auto terminator = resulter.get_output_chan();
-
-    std::ifstream ifile(opts.InputFile, std::ifstream::binary);
-    if(!ifile)
-        throw error("failed to open file [" + opts.InputFile + "]");
-
-    std::pmr::pool_options pool_opts{opts.QueueSize, opts.BlockSize};
-    auto pool = std::pmr::synchronized_pool_resource{pool_opts};
-    for (size_t i=0; ifile && !terminator->is_closed(); i++) {
-        std::pmr::vector<char> buff(opts.BlockSize, &pool);
-        ifile.read(buff.data(), buff.size());
-        size_t readed = ifile.gcount();
-        if(readed != opts.BlockSize && !ifile.eof())
+    auto stopped = [&input, &terminator] { return input->is_closed() || terminator->is_closed(); };
+
+    // Shared by all readers (processed ranges are released out of order).
+    std::optional<cache_dropper> dropper;
+    if(opts.Cache == CachePolicy::drop)
+        dropper.emplace(opts.InputFile, opts.Offset);
+
+    // Reads one job from `pos` of processed range and pushes it to workers.
+    // Returns false if pipe is stopped.
+    auto push_job = [&](file_reader& ifile, uint64_t pos, size_t size) {
+        auto lease = budget.acquire(size, stopped);
+        if (!lease)
+            return false;
+
+        std::vector<char> buff(size);
+        if(ifile.read_at(buff.data(), buff.size(), opts.Offset + pos) != buff.size())
             throw error("failed to read input file");
-        if(readed == 0)
-            break;
-            
-        buff.resize(readed);
-        if (!input->push(std::move(job_t{i, std::move(buff)})))
-            break;
-    }
+
+        // Data is copied to the job buffer - so cached pages are not needed anymore.
+        if(dropper)
+            dropper->release(opts.Offset + pos, size);
+
+        return input->push(std::move(job_t{opts.FirstChunk + pos / opts.BlockSize, std::move(buff), std::move(lease)}));
+    };
+
+    // Reads every `step`-th job starting from `first` one.
+    // Next job of this reader is prefetched while current one is waiting in the queue.
+    auto producer = [&](size_t first, size_t step) {
+        file_reader ifile(opts.InputFile);
+        for (uint64_t pos = uint64_t{first} * job_size; pos < opts.Length && !terminator->is_closed(); pos += uint64_t{step} * job_size) {
+            uint64_t next = pos + uint64_t{step} * job_size;
+            if(next < opts.Length)
+                ifile.prefetch(opts.Offset + next, std::min<uint64_t>(job_size, opts.Length - next));
+
+            if (!push_job(ifile, pos, std::min<uint64_t>(job_size, opts.Length - pos)))
+                break;
+        }
+    };
+
+    // Follows growing file: pushes complete blocks (up to one job at once) as soon as they are written.
+    // Trailing partial block is pushed when file is removed, writer closes it and does not reopen or append it
+    // for follow_close_delay, or it does not grow for Options.FollowTimeout.
+    // Watcher is created before reading - so no change can be missed.
+    auto follower = [&]() {
+        file_watcher watcher(opts.InputFile);
+        file_reader ifile(opts.InputFile);
+        bool finishing = false;
+        auto idle_since = std::chrono::steady_clock::now();
+        std::optional<std::chrono::steady_clock::time_point> closed_since;
+        uint64_t pos = 0;
+        while (!terminator->is_closed()) {
+            uint64_t fsize = ifile.size();
+            uint64_t avail = fsize > opts.Offset + pos ? fsize - opts.Offset - pos : 0;
+            size_t size = std::min<uint64_t>(avail / opts.BlockSize * opts.BlockSize, job_size);
+            if (size != 0) {
+                if (!push_job(ifile, pos, size))
+                    break;
+                pos += size;
+                continue;
+            }
+
+            if (finishing) {
+                if (avail != 0 && push_job(ifile, pos, avail))
+                    pos += avail;
+                break;
+            }
+
+            // Wait by short intervals to notice stopped pipe.
+            auto ev = watcher.wait(std::chrono::seconds(1));
+            auto now = std::chrono::steady_clock::now();
+            if (ev == file_watcher::event::grown || ev == file_watcher::event::opened) {
+                idle_since = now;
+                closed_since.reset();
+            } else if (ev == file_watcher::event::closed) {
+                idle_since = now;
+                closed_since = now;
+            }
+            finishing = ev == file_watcher::event::removed || (closed_since && now - *closed_since >= follow_close_delay)
+                || now - idle_since >= opts.FollowTimeout;
+        }
+
+        // Writer can still append after following is finished - hash of the last chunk does not cover it then.
+        if (!terminator->is_closed() && ifile.size() > opts.Offset + pos)
+            std::cout << "WARNING: input file has grown after following was finished (last chunk is incomplete)" << std::endl;
+    };
+
+    if (opts.Follow)
+        follower();
+    else
+        run_readers(opts.Readers, input, producer);
 
     // Any exceptions from workers will be raised here
     input->close();
@@ -132,25 +290,55 @@ static void do_with_streaming(Options opts, hasher hash, const resulter_function
 }
 
 // Do the work using "mmap" aproach.
-// Producer (main thread) will map whole file to virtual memmory and pushh memmory segments to input chanel of workers pool.
-// No need to limit memmory usage. Options.QueueSize has its maximum value.
-static void do_with_mapping(filehasher::Options opts, hasher& hash, const resulter_function_t& rfunc) {
+// Producer (main thread) will map file (or selected range) to virtual memmory by windows of mapping_window_size
+// and pushh memmory segments (batches of Options.BatchSize chunks) to input chanel of workers pool.
+// Mapped windows are accounted in memory budget. Window is unmapped when all its jobs are done.
+template<class Hasher>
+static void do_with_mapping(filehasher::Options opts, Hasher hash, memory_budget& budget, const resulter_function_t& rfunc) {
     namespace bi = boost::interprocess;
+
+    // Used only for page cache hints. Should outlive all windows (they can be released by workers).
+    file_reader cache(opts.InputFile);
+    std::optional<cache_dropper> dropper;
+    if(opts.Cache == CachePolicy::drop)
+        dropper.emplace(opts.InputFile, opts.Offset);
+
+    // Window is dropped from page cache (if requested) after it is unmapped.
+    struct window_t {
+        bi::mapped_region   region;
+        memory_lease        lease;
+        cache_dropper       *dropper;
+        uint64_t            offset;
+        size_t              size;
+
+        window_t(const bi::file_mapping& file, uint64_t offset, size_t size, memory_lease&& lease, cache_dropper *dropper)
+            : region(file, bi::read_only, offset, size), lease(std::move(lease)), dropper(dropper), offset(offset), size(size)
+        {
+            region.advise(bi::mapped_region::advice_sequential);
+        }
+        ~window_t() {
+            if(dropper == nullptr)
+                return;
+            bi::mapped_region().swap(region);
+            dropper->release(offset, size);
+        }
+    };
     struct job_t {
-        size_t      chunk_number    {0};
-        size_t      size            {0};
-        const void  *addr           {nullptr};
+        size_t                          chunk_number    {0};
+        size_t                          size            {0};
+        const void                      *addr           {nullptr};
+        std::shared_ptr<const window_t> window;
     };
 
-    piped_workers_pool<job_t, result_t>
-    workers (opts.Workers, opts.QueueSize, [hash](const job_t& job) mutable {
-        hash.process_bytes(job.addr, job.size);
-        return result_t{job.chunk_number, hash.result()};
+    piped_workers_pool<job_t, results_batch_t>
+    workers (opts.Workers, opts.QueueSize, [hash, bsize = opts.BlockSize, &budget](job_t job) mutable {
+        auto results = hash_batch(hash, static_cast<const char*>(job.addr), job.size, bsize, job.chunk_number);
+        return results_batch_t{budget, std::move(results)};
     });
     
-    piped_workers_pool<result_t>
-    resulter (1, opts.QueueSize, workers, [&rfunc](result_t&& result){
-        rfunc(std::move(result));
+    piped_workers_pool<results_batch_t>
+    resulter (1, opts.QueueSize, workers, [&rfunc](results_batch_t batch){
+        for (auto&& r : batch.results) rfunc(std::move(r));
     });
 
     try {
@@ -161,15 +349,29 @@ static void do_with_mapping(filehasher::Options opts, hasher& hash, const result
         // terminator - is the last chanel in the pipe.
         // If it is closed before all the job is done - something wrong happend. Producer should break and "wait" waorkers to get exception.
         auto terminator = resulter.get_output_chan();
+        auto stopped = [&input, &terminator] { return input->is_closed() || terminator->is_closed(); };
     
         bi::file_mapping ifile(opts.InputFile.c_str(), bi::read_only);
-        bi::mapped_region region(ifile, bi::read_only);
 
-        size_t size = region.get_size();
-        const void* addr = region.get_address();
-        for (size_t i = 0, num = 0; i < size && !terminator->is_closed(); i += opts.BlockSize) {
-            if(!input->push(job_t{num++,std::min((size_t)opts.BlockSize, size - i), (const char*)addr + i}))
+        // Window holds whole number of jobs and should leave room for the next one in memory budget.
+        const size_t job_size = opts.BlockSize * opts.BatchSize;
+        const size_t window_size = std::max(std::min(mapping_window_size, budget.get_limit() / 2) / job_size, size_t{1}) * job_size;
+        for (uint64_t wpos = 0; wpos < opts.Length && !terminator->is_closed(); wpos += window_size) {
+            size_t size = std::min<uint64_t>(window_size, opts.Length - wpos);
+            auto lease = budget.acquire(size, stopped);
+            if (!lease)
                 break;
+
+            auto window = std::make_shared<const window_t>(ifile, opts.Offset + wpos, size, std::move(lease), dropper ? &*dropper : nullptr);
+            if(wpos + size < opts.Length)
+                cache.prefetch(opts.Offset + wpos + size, std::min<uint64_t>(window_size, opts.Length - wpos - size));
+
+            const char* addr = static_cast<const char*>(window->region.get_address());
+            size_t num = opts.FirstChunk + wpos / opts.BlockSize;
+            for (size_t i = 0; i < size; i += job_size, num += opts.BatchSize) {
+                if(!input->push(job_t{num, std::min(job_size, size - i), addr + i, window}))
+                    break;
+            }
         }
 
         // Any exceptions from workers will be raised here
@@ -181,20 +383,181 @@ static void do_with_mapping(filehasher::Options opts, hasher& hash, const result
     }
 }
 
+// Compare two files (Options.DiffFile and Options.InputFile) chunk by chunk.
+// Readers read the same batch of both files in lockstep. Second file is prefetched while the first one is read - so both reads are overlapped.
+// Workers compare raw bytes (both chunks are already in memory - hashing would only add CPU work and collisions).
+// Results writer restores order of batches, coalesces adjacent differing chunks and writes byte ranges.
+// Returns number of written ranges. Stops reading when Options.MaxDiffs ranges are written.
+static size_t do_diff(Options opts, memory_budget& budget, std::ostream& dst) {
+    struct range_t {
+        uint64_t begin  {0};
+        uint64_t end    {0};
+    };
+    struct job_t {
+        size_t                  job_number  {0};
+        uint64_t                pos         {0};
+        size_t                  size        {0};
+        std::vector<char>       left;
+        std::vector<char>       right;
+        memory_lease            lease;
+    };
+    // Ranges of one job passed from workers to results writer (and kept there until previous jobs are done).
+    // Accounted in memory budget without blocking - like results_batch_t.
+    struct ranges_t {
+        size_t                  job_number  {0};
+        std::vector<range_t>    ranges;
+        memory_lease            lease;
+    };
+
+    const size_t job_size = opts.BlockSize * opts.BatchSize;
+
+    // Missing bytes (the rest of larger file) are different too.
+    piped_workers_pool<job_t, ranges_t>
+    workers (opts.Workers, opts.QueueSize, [bsize = opts.BlockSize, base = opts.Offset, &budget](job_t job) {
+        ranges_t res{job.job_number, {}, {}};
+        for (size_t offset = 0; offset < job.size; offset += bsize) {
+            size_t size = std::min(bsize, job.size - offset);
+            bool same = offset + size <= job.left.size() && offset + size <= job.right.size()
+                && std::memcmp(job.left.data() + offset, job.right.data() + offset, size) == 0;
+            if (same)
+                continue;
+
+            uint64_t begin = base + job.pos + offset;
+            if (!res.ranges.empty() && res.ranges.back().end == begin)
+                res.ranges.back().end = begin + size;
+            else
+                res.ranges.push_back(range_t{begin, begin + size});
+        }
+        res.lease = budget.charge(sizeof(ranges_t) + 4 * sizeof(void*) + res.ranges.capacity() * sizeof(range_t));
+        return res;
+    });
+
+    size_t found = 0;
+    std::atomic<bool> enough{false};
+    std::optional<range_t> current;
+    auto write_range = [&](const range_t& r) {
+        if (enough) return;
+        dst << r.begin << "-" << r.end - 1 << " (" << r.end - r.begin << " bytes)\n";
+        if (!dst) throw error("failed to write results");
+        if (++found == opts.MaxDiffs) enough = true;
+    };
+
+    // Batches come out of order - keep them until all previous ones are done.
+    std::map<size_t, ranges_t> pending;
+    size_t next_job = 0;
+    piped_workers_pool<ranges_t>
+    resulter (1, opts.QueueSize, workers, [&](ranges_t batch) {
+        pending.emplace(batch.job_number, std::move(batch));
+        for (auto it = pending.begin(); it != pending.end() && it->first == next_job; it = pending.erase(it), next_job++) {
+            for (auto&& r : it->second.ranges) {
+                if (current && current->end == r.begin) {
+                    current->end = r.end;
+                    continue;
+                }
+                if (current) write_range(*current);
+                current = r;
+            }
+        }
+    });
+
+    auto input = workers.get_input_chan();
+    auto terminator = resulter.get_output_chan();
+    auto stopped = [&input, &terminator, &enough] { return input->is_closed() || terminator->is_closed() || enough; };
+
+    std::optional<cache_dropper> left_dropper, right_dropper;
+    if(opts.Cache == CachePolicy::drop) {
+        left_dropper.emplace(opts.DiffFile, opts.Offset);
+        right_dropper.emplace(opts.InputFile, opts.Offset);
+    }
+
+    // Reads every `step`-th batch of both files starting from `first` one.
+    auto producer = [&](size_t first, size_t step) {
+        file_reader left(opts.DiffFile);
+        file_reader right(opts.InputFile);
+        for (uint64_t pos = uint64_t{first} * job_size, num = first; pos < opts.Length && !stopped(); pos += uint64_t{step} * job_size, num += step) {
+            size_t size = std::min<uint64_t>(job_size, opts.Length - pos);
+            auto lease = budget.acquire(size * 2, stopped);
+            if (!lease)
+                break;
+
+            right.prefetch(opts.Offset + pos, size);
+            std::vector<char> lbuff(size);
+            lbuff.resize(left.read_at(lbuff.data(), size, opts.Offset + pos));
+            std::vector<char> rbuff(size);
+            rbuff.resize(right.read_at(rbuff.data(), size, opts.Offset + pos));
+
+            if(opts.Cache == CachePolicy::drop) {
+                left_dropper->release(opts.Offset + pos, size);
+                right_dropper->release(opts.Offset + pos, size);
+            }
+            uint64_t next = pos + uint64_t{step} * job_size;
+            if(next < opts.Length)
+                left.prefetch(opts.Offset + next, std::min<uint64_t>(job_size, opts.Length - next));
+
+            if (!input->push(job_t{num, pos, size, std::move(lbuff), std::move(rbuff), std::move(lease)}))
+                break;
+        }
+    };
+
+    run_readers(opts.Readers, input, producer);
+
+    // Any exceptions from workers will be raised here
+    input->close();
+    workers.wait();
+    resulter.wait();
+
+    if (current)
+        write_range(*current);
+    return found;
+}
+
 // Store results to provided container (will be ordered).
 // Results will be written at the and of execution.
-void process_ordered_results(result_t&& result, std::multiset<result_t>& dst) {
-    if(dst.size() >= results_limit)
-        throw error("too many results (try unordered output)");
+// Stored results are accounted in memory budget (with provided lease) and can use only half of it.
+void process_ordered_results(result_t&& result, std::multiset<result_t>& dst, memory_lease& lease, size_t limit) {
+    size_t size = ordered_result_size(result);
+    if(lease.get_size() + size > limit / 2)
+        throw error("too many results (try unordered output or increase memory budget)");
+    lease.grow(size);
     dst.insert(std::move(result));
 }
 
 // Just write unordered chunks directly to provided output stream...
-void process_unordered_results(result_t&& result, std::ostream& dst) {
-    dst << result.cunk_number << ": " << result.hash << std::endl;
+// Output is not flushed for each result (it is too expensive for small blocks) - it will be flushed at the end.
+// Except following growing file - results should be available immediately.
+void process_unordered_results(result_t&& result, std::ostream& dst, bool flush) {
+    dst << result.cunk_number << ": " << result.hash << '\n';
+    if (flush) dst.flush();
     if (!dst) throw error("failed to write results");
 }
 
+// Passes only not completed chunks to results processing and tracks progress.
+// Output is flushed before progress is stored - so checkpoint never claims results that are not written.
+void process_checkpointed_results(result_t&& result, bool ordered, checkpoint& chkpt, std::ostream& dst, const resulter_function_t& rfunc) {
+    if(chkpt.is_done(result.cunk_number))
+        return;
+
+    size_t chunk = result.cunk_number;
+    if(ordered)
+        chkpt.keep(chunk, result.hash);
+    rfunc(std::move(result));
+    chkpt.complete(chunk);
+
+    if(chkpt.save_due()) {
+        if (!dst.flush()) throw error("failed to write results");
+        auto written = dst.tellp();
+        chkpt.save(written > 0 ? static_cast<uint64_t>(written) : 0);
+    }
+}
+
+// Adjusts range of file to be processed to start from the first not completed chunk.
+static void skip_completed_chunks(Options& opts, size_t next_chunk) {
+    uint64_t skip = uint64_t{next_chunk - opts.FirstChunk} * opts.BlockSize;
+    opts.Offset += std::min(skip, opts.Length);
+    opts.Length -= std::min(skip, opts.Length);
+    opts.FirstChunk = next_chunk;
+}
+
 int main(int argc, char *argv[]) {
 
     try {
@@ -208,48 +571,113 @@ int main(int argc, char *argv[]) {
             return 0;
         }
 
+        // Load progress if resume was requested and skip all completed chunks.
+        // Fingerprint is taken before range adjustment - it should match the one stored by the interrupted run.
+        std::optional<checkpoint> chkpt;
+        if(!opts.Checkpoint.empty()) {
+            chkpt.emplace(opts.Checkpoint, MakeFingerprint(opts), opts.FirstChunk);
+            if(opts.Resume) {
+                chkpt->load();
+                skip_completed_chunks(opts, chkpt->next_chunk());
+            }
+        }
+
         // Select output stream depending on 'OutputFile' options flag.
+        // Unordered results of interrupted run are already written - so append them on resume.
+        // Results written after the last stored progress will be calculated again - so drop them.
         std::ofstream ofile;
         if(!opts.OutputFile.empty()) {
-            ofile.open(opts.OutputFile, std::ifstream::trunc);
+            if(opts.Resume && !opts.Sorted) {
+                std::error_code ec;
+                std::filesystem::resize_file(opts.OutputFile, chkpt->output_size(), ec);
+                if(ec) throw error("failed to truncate output file [" + opts.OutputFile + "]: " + ec.message());
+            }
+            ofile.open(opts.OutputFile, (opts.Resume && !opts.Sorted) ? std::ofstream::app : std::ofstream::trunc);
             if(!ofile) throw error("failed to open output file [" + opts.OutputFile + "]");
         }
         std::ostream& output = ofile.is_open() ? ofile : std::cout;
 
+        // All the pipeline stages share one memory budget.
+        memory_budget budget(opts.MemoryLimit);
+
+        // Compare files if requested - exit code is '1' if they differ (like `cmp` does).
+        // Empty files are equal (there is nothing to read).
+        if(opts.Cmd == Command::diff) {
+            std::cout << "Running diff: ";
+            std::cout << "queue [" << opts.QueueSize << "], workers [" << opts.Workers << "], readers [" << opts.Readers << "], batch [" << opts.BatchSize << "]";
+            std::cout << "..." << std::endl;
+            auto stime = std::chrono::high_resolution_clock::now();
+
+            size_t found = opts.Length ? do_diff(opts, budget, output) : 0;
+            if (!output.flush())
+                throw error("failed to write results");
+
+            auto etime = std::chrono::high_resolution_clock::now();
+            std::cout << "Done [with diff] in " << std::chrono::duration_cast<std::chrono::microseconds>(etime-stime).count();
+            std::cout << ", peak memory [" << budget.get_peak() << "], differences [" << found << "]" << std::endl;
+            return found ? 1 : 0;
+        }
+
         // Select result processing method depending on 'Sorted' options flag.
         std::multiset<result_t> results;
+        auto results_lease = budget.charge(0);
         resulter_function_t rfunc;
         if (opts.Sorted) {
-            rfunc = [&results](result_t&& r) { process_ordered_results(std::move(r), results);};
+            rfunc = [&results, &results_lease, &budget](result_t&& r) { process_ordered_results(std::move(r), results, results_lease, budget.get_limit());};
         } else {
-            rfunc = [&output](result_t&& r) { process_unordered_results(std::move(r), output);};
+            rfunc = [&output, flush = opts.Follow](result_t&& r) { process_unordered_results(std::move(r), output, flush);};
+        }
+
+        // Track progress if checkpoint was requested.
+        // Ordered results are not written until the end - so they are stored in checkpoint results log.
+        if (chkpt) {
+            if (opts.Sorted && opts.Resume) {
+                chkpt->restore([&results, &results_lease, &budget](size_t chunk, std::string hash) {
+                    process_ordered_results(result_t{chunk, std::move(hash)}, results, results_lease, budget.get_limit());
+                });
+            }
+            rfunc = [&opts, &chkpt, &output, rfunc = std::move(rfunc)](result_t&& r) {
+                process_checkpointed_results(std::move(r), opts.Sorted, *chkpt, output, rfunc);
+            };
         }
 
-        // Get hashing function (only CRC16 with Boost implementation is supported).
+        // Get hashing function (single algorithm or set of them calculated in one pass).
         auto hash = GetHasher(opts);
 
         std::cout << "Running: ";
-        std::cout << "queue [" << opts.QueueSize << "], workers [" << opts.Workers << "]";
+        std::cout << "queue [" << opts.QueueSize << "], workers [" << opts.Workers << "], batch [" << opts.BatchSize << "]";
+        if (opts.Resume)
+            std::cout << ", resumed from chunk [" << opts.FirstChunk << "]";
         std::cout << "..." << std::endl;
         auto stime = std::chrono::high_resolution_clock::now();
 
         // Select input file reading mode (streamed/maped) depending on 'Mapping' options flag.
-        if(opts.Mapping && (opts.Workers > 0))
-            do_with_mapping(opts, hash, rfunc);
-        else if (opts.Workers < 1)
-            do_with_sync(opts, hash, rfunc);
-        else 
-            do_with_streaming(opts, hash, rfunc);
+        // Hashing algorithm is dispatched only once here - all the pipeline is specialized for concrete hasher type.
+        std::visit([&](const auto& concrete) {
+            if(opts.Length == 0)
+                return;
+            if(opts.Mapping && (opts.Workers > 0))
+                do_with_mapping(opts, concrete, budget, rfunc);
+            else if (opts.Workers < 1)
+                do_with_sync(opts, concrete, budget, rfunc);
+            else 
+                do_with_streaming(opts, concrete, budget, rfunc);
+        }, hash);
 
         // If orderd output was selected - flush it.
         if (opts.Sorted) {
             for (auto&& r : results) {
-                output << r.cunk_number << ": " << r.hash << std::endl;
+                output << r.cunk_number << ": " << r.hash << '\n';
             }
         }
+        if (!output.flush())
+            throw error("failed to write results");
+        if (chkpt)
+            chkpt->remove();
 
         auto etime = std::chrono::high_resolution_clock::now();
-        std::cout << "Done [with " << (opts.Mapping ? "mapping": "streaming") << "] in " << std::chrono::duration_cast<std::chrono::microseconds>(etime-stime).count() << std::endl;
+        std::cout << "Done [with " << (opts.Mapping ? "mapping": "streaming") << "] in " << std::chrono::duration_cast<std::chrono::microseconds>(etime-stime).count();
+        std::cout << ", peak memory [" << budget.get_peak() << "]" << std::endl;
     }catch(const options_error& e) {
         std::cout << "ERROR while parsing options: " << e.what() << std::endl;
         PromptUsage(std::cout);
@@ -60,6 +60,36 @@ static std::optional<size_t> try_parse_size(std::string value)
     return std::nullopt;
 }
 
+static std::optional<std::pair<size_t, size_t>> try_parse_range(std::string value)
+{
+    auto first = size_t{0};
+    auto last = size_t{0};
+    auto getter = std::tie(first, last);
+
+    if( x3::parse(value.cbegin(), value.cend(), x3::ulong_ >> '-' >> x3::ulong_ >> x3::eoi, getter) && first <= last) {
+        return std::make_pair(first, last);
+    }
+    return std::nullopt;
+}
+
+// Parses comma separated list of algorithm names (each one can be used only once).
+static std::optional<std::vector<filehasher::hash_types>> try_parse_algorithms(std::string value)
+{
+    std::vector<std::string> names;
+    if( !x3::parse(value.cbegin(), value.cend(), +(x3::alnum) % ',' >> x3::eoi, names) )
+        return std::nullopt;
+
+    std::vector<filehasher::hash_types> res;
+    for (auto&& name : names) {
+        auto type = std::find_if(std::begin(filehasher::all_hash_types), std::end(filehasher::all_hash_types),
+            [&name](auto t) { return filehasher::to_string(t) == name; });
+        if (type == std::end(filehasher::all_hash_types) || std::find(res.begin(), res.end(), *type) != res.end())
+            return std::nullopt;
+        res.push_back(*type);
+    }
+    return res;
+}
+
 static const po::options_description get_options() {
     static auto once = false;
     static po::options_description options{about};
@@ -75,8 +105,21 @@ static const po::options_description get_options() {
             ("outfile,o", po::value<std::string>()->value_name("PATH"), "Path to the file to write results (`stdout` if not specified).")
             ("workers,w", po::value<std::string>()->default_value(std::to_string(def_workers))->value_name("NUM"), "Number of workers to calculate hashes (number of H/W threads supported - if not specified).\n'0' value can be used to forse sync processing.")
             ("blocksize,b", po::value<std::string>()->default_value("1M")->value_name("SIZE"), "Size of block. Scale suffixes are allowed:\n`K` - mean Kbyte(example 128K)\n`M` - mean Mbyte (example 10M)\n`G` - mean Gbyte (example 1G)")
-            ("ordered", "Ennables results ordering by chunk number.\nOrdering option has restriction in 100000 chunks. Unordered output is faster and uses less memory.")
-            ("mapping", "Ennables `mmap` option instead of stream reading. Could be faster and does not usess physical RAM memory to store chunks.\nOn Win x86 will definitely fail with files more than 2GB.");
+            ("algo,a", po::value<std::string>()->default_value("crc16")->value_name("LIST"), "Comma separated list of hash algorithms (`crc16`, `crc32`, `sha1`, `sha256`).\n`sha256` is the only collision resistant one (use it to detect malicious changes).\nAll digests are calculated with one read pass and written in one record.")
+            ("readers,r", po::value<std::string>()->default_value("1")->value_name("NUM"), "Number of threads reading input file in parallel (each one reads its own chunks).\nCan help on striped RAID and network block devices. Ignored with `--mapping`.")
+            ("offset", po::value<std::string>()->value_name("SIZE"), "Start processing from this byte offset (scale suffixes are allowed).\nChunks are numbered from the offset.")
+            ("length", po::value<std::string>()->value_name("SIZE"), "Process only this number of bytes (scale suffixes are allowed).")
+            ("chunks", po::value<std::string>()->value_name("A-B"), "Process only chunks from A to B (inclusive).\nCan not be combined with `--offset` and `--length`.")
+            ("memory,m", po::value<std::string>()->default_value("1G")->value_name("SIZE"), "Memory budget for chunk buffers, mapped regions and results (scale suffixes are allowed).\nReading waits when it is exhausted.")
+            ("ordered", "Ennables results ordering by chunk number.\nOrdered results can use only half of memory budget. Unordered output is faster and uses less memory.")
+            ("checkpoint", po::value<std::string>()->value_name("PATH"), "Periodically store progress to the checkpoint file. It is removed when processing is done.\nUnordered output requires `--outfile` (it is truncated to stored progress on resume).")
+            ("resume", "Continue interrupted processing from the checkpoint file (`--checkpoint` is required).\nUnordered results are appended to the output file.")
+            ("cache-policy", po::value<std::string>()->default_value("keep")->value_name("keep|drop"), "Page cache policy for input file.\n`keep` - leave it to OS\n`drop` - evict already hashed ranges from page cache (for hosts shared with other services).")
+            ("follow", "Follow growing file (append-only logs, captures in progress): hash new blocks as soon as they are written.\nTrailing partial block is hashed when writer closes file and does not reopen it for 2 seconds, or file does not grow for `--follow-timeout`.\nCan not be combined with `--mapping`, `--length`, `--chunks` and `--checkpoint`.")
+            ("follow-timeout", po::value<std::string>()->default_value("30")->value_name("SEC"), "Finish following if file does not grow for this number of seconds.")
+            ("diff", po::value<std::string>()->value_name("PATH"), "Compare this file with input file (`filehasher --diff A B`) chunk by chunk and write differing byte ranges.\nBoth files are read in lockstep. Can not be combined with `--follow`, `--mapping`, `--ordered` and `--checkpoint`.")
+            ("max-diffs", po::value<std::string>()->default_value("0")->value_name("NUM"), "Stop comparing after this number of differing ranges ('0' - no limit).")
+            ("mapping", "Ennables `mmap` option instead of stream reading. Could be faster and does not usess physical RAM memory to store chunks.\nFile is mapped by windows accounted in memory budget.");
     }
 
     return options;
@@ -113,6 +156,15 @@ namespace filehasher {
             if(opts.BlockSize == 0)
                 throw po::validation_error{po::validation_error::invalid_option_value, "blocksize"};
 
+            auto algos = try_parse_algorithms(vm["algo"].as<std::string>());
+            if(!algos)
+                throw po::validation_error{po::validation_error::invalid_option_value, "algo"};
+            opts.Algorithms = *algos;
+
+            opts.MemoryLimit = try_parse_size(vm["memory"].as<std::string>()).value_or(0);
+            if(opts.MemoryLimit == 0)
+                throw po::validation_error{po::validation_error::invalid_option_value, "memory"};
+
             if(vm.count("outfile"))
                 opts.OutputFile = vm["outfile"].as<std::string>();
 
@@ -122,28 +174,140 @@ namespace filehasher {
             if(vm.count("mapping"))
                 opts.Mapping = true;
 
-            size_t fsize = std::filesystem::file_size(opts.InputFile);
-            size_t blocks_count = (fsize / opts.BlockSize) + ((fsize % opts.BlockSize) ? 1 : 0);
-            if (blocks_count == 0)
+            auto cache = vm["cache-policy"].as<std::string>();
+            if(cache == "keep")
+                opts.Cache = CachePolicy::keep;
+            else if(cache == "drop")
+                opts.Cache = CachePolicy::drop;
+            else
+                throw po::validation_error{po::validation_error::invalid_option_value, "cache-policy"};
+
+            // Unordered results written after the last stored progress are written again on resume.
+            // It is fine for output file (it is truncated), but not for `stdout`.
+            if(vm.count("checkpoint")) {
+                opts.Checkpoint = vm["checkpoint"].as<std::string>();
+                if(opts.OutputFile.empty() && !opts.Sorted)
+                    throw options_error("`--checkpoint` requires `--outfile` for unordered output");
+            }
+
+            if(vm.count("resume")) {
+                if(opts.Checkpoint.empty())
+                    throw options_error("`--resume` requires `--checkpoint`");
+                opts.Resume = true;
+            }
+
+            if(vm.count("diff")) {
+                if(vm.count("follow") || opts.Mapping || opts.Sorted || !opts.Checkpoint.empty())
+                    throw options_error("`--diff` can not be combined with `--follow`, `--mapping`, `--ordered` and `--checkpoint`");
+                auto maxd = try_parse_unsigned(vm["max-diffs"].as<std::string>());
+                if(!maxd)
+                    throw po::validation_error{po::validation_error::invalid_option_value, "max-diffs"};
+                opts.Cmd = Command::diff;
+                opts.DiffFile = vm["diff"].as<std::string>();
+                opts.MaxDiffs = *maxd;
+            }
+
+            if(vm.count("follow")) {
+                if(opts.Mapping || vm.count("length") || vm.count("chunks") || !opts.Checkpoint.empty())
+                    throw options_error("`--follow` can not be combined with `--mapping`, `--length`, `--chunks` and `--checkpoint`");
+                auto tmo = try_parse_unsigned(vm["follow-timeout"].as<std::string>()).value_or(0);
+                if(tmo == 0)
+                    throw po::validation_error{po::validation_error::invalid_option_value, "follow-timeout"};
+                opts.Follow = true;
+                opts.FollowTimeout = std::chrono::seconds(tmo);
+            }
+
+            auto rdrs = try_parse_unsigned(vm["readers"].as<std::string>()).value_or(0);
+            if (rdrs == 0)
+                throw po::validation_error{po::validation_error::invalid_option_value, "readers"};
+            opts.Readers = rdrs;
+
+            // Followed file can be empty yet.
+            // Compared files can have different sizes - the rest of larger one is a difference (both empty ones are equal).
+            uint64_t fsize = std::filesystem::file_size(opts.InputFile);
+            if (opts.Cmd == Command::diff)
+                fsize = std::max<uint64_t>(fsize, std::filesystem::file_size(opts.DiffFile));
+            if (fsize == 0 && !opts.Follow && opts.Cmd != Command::diff)
                 throw options_error("input file is empty");
 
+            // Select range of file to be processed
+            auto length = std::numeric_limits<uint64_t>::max();
+            if(vm.count("chunks")) {
+                if(vm.count("offset") || vm.count("length"))
+                    throw options_error("`--chunks` can not be combined with `--offset` or `--length`");
+                auto range = try_parse_range(vm["chunks"].as<std::string>());
+                if(!range || range->first > fsize / opts.BlockSize)
+                    throw po::validation_error{po::validation_error::invalid_option_value, "chunks"};
+                opts.FirstChunk = range->first;
+                opts.Offset = uint64_t{range->first} * opts.BlockSize;
+                if(range->second - range->first < length / opts.BlockSize)
+                    length = uint64_t{range->second - range->first + 1} * opts.BlockSize;
+            }
+            if(vm.count("offset")) {
+                auto offset = try_parse_size(vm["offset"].as<std::string>());
+                if(!offset)
+                    throw po::validation_error{po::validation_error::invalid_option_value, "offset"};
+                opts.Offset = *offset;
+            }
+            if(vm.count("length")) {
+                auto len = try_parse_size(vm["length"].as<std::string>()).value_or(0);
+                if(len == 0)
+                    throw po::validation_error{po::validation_error::invalid_option_value, "length"};
+                length = len;
+            }
+            // Range of followed file is not limited (it will grow).
+            // Nothing to compare in empty files.
+            if(opts.Follow) {
+                opts.Length = std::numeric_limits<uint64_t>::max();
+            } else if (fsize == 0) {
+                opts.Length = 0;
+            } else {
+                if(opts.Offset >= fsize)
+                    throw options_error("selected range is out of input file");
+                opts.Length = std::min(length, fsize - opts.Offset);
+            }
+
+            uint64_t blocks_count = (opts.Length / opts.BlockSize) + ((opts.Length % opts.BlockSize) ? 1 : 0);
+
             //Adjust workers count and queue size to satisfy all limitations
 
+            // Followed file is processed by workers pool with one reader (no sync execution).
+            if (opts.Follow) {
+                opts.Workers = std::max(opts.Workers, size_t{1});
+                opts.Readers = 1;
+            }
+            // Compared files are always processed by workers pool.
+            if (opts.Cmd == Command::diff)
+                opts.Workers = std::max(opts.Workers, size_t{1});
+
             // If only 1 file block will be processed set queue size and workers to 0 to fall back to sync execution
             // If 0 workers were requested - set queue size to 0 to fall back to sync execution
-            if (blocks_count == 1 || opts.Workers == 0) {
+            if ((blocks_count == 1 && opts.Cmd != Command::diff) || opts.Workers == 0) {
                 opts.QueueSize = opts.Workers = 0;
                 return opts;
             }
             
+            // Pack small blocks in batches (one job for workers pool) to fit batch_target_size (and leave room for several jobs in memory budget).
+            opts.BatchSize = std::max(std::min(batch_target_size, opts.MemoryLimit / 8) / opts.BlockSize, size_t{1});
+            uint64_t jobs_count = (blocks_count / opts.BatchSize) + ((blocks_count % opts.BatchSize) ? 1 : 0);
+
             // Check memory limits and calculate queue size.
-            // For mapping mode - use max queue size (blocks will not occupie phisical RAM).
-            size_t memory_blocks_limit = soft_memmory_limit / opts.BlockSize;
-            opts.QueueSize = opts.Mapping ? queue_limit : memory_blocks_limit > 0 ? std::min(memory_blocks_limit - 1, queue_limit) : 0;
+            // For mapping mode - use max queue size (mapped windows are limited by memory budget itself).
+            // Fall back to sync execution if less than two jobs can fit in memory budget.
+            // Job of diff holds buffers for both files.
+            size_t job_buffers = (opts.Cmd == Command::diff) ? 2 : 1;
+            size_t memory_blocks_limit = opts.MemoryLimit / (opts.BlockSize * opts.BatchSize * job_buffers);
+            opts.QueueSize = memory_blocks_limit < 2 ? 0 : opts.Mapping ? queue_limit : std::min(memory_blocks_limit - 1, queue_limit);
+            if (opts.QueueSize == 0 && opts.Follow)
+                throw options_error("block is too large to follow file (increase memory budget)");
+            if (opts.QueueSize == 0 && opts.Cmd == Command::diff)
+                throw options_error("block is too large to compare files (increase memory budget)");
             // The number of workers should be less or equal to queue size to prevent new blocks allocations
             opts.Workers = std::min(opts.Workers, opts.QueueSize);
-            // The number of workers should not be grater than number of blocks to count
-            opts.Workers = std::min(opts.Workers, blocks_count);
+            // The number of workers should not be grater than number of jobs to do (but there is at least one - even if nothing to do)
+            opts.Workers = std::min<uint64_t>(opts.Workers, std::max<uint64_t>(jobs_count, 1));
+            // Each reader should get at least one job
+            opts.Readers = std::min<uint64_t>(opts.Readers, std::max<uint64_t>(jobs_count, 1));
 
         } catch (const std::filesystem::filesystem_error& e){
             throw options_error(e.what());
@@ -162,8 +326,7 @@ namespace filehasher {
     }
 
     hasher GetHasher(const Options& opts) {
-        //Only CRC16 is implemented.
-        return hasher{hasher::hash_types::crc_16};
+        return make_hasher(opts.Algorithms);
     }
 
 }//namespace filehasher
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <stdexcept>
+#include <cstdint>
+#include <vector>
 
 #include "commondefs.hpp"
 #include "hasher.hpp"
@@ -13,18 +15,42 @@ namespace filehasher {
         explicit options_error(const std::string& what) : error(what) {}
     };
 
-    enum class Command { help, run };
+    enum class Command { help, run, diff };
+
+    // What to do with page cache filled by reading input file:
+    // keep - leave it to OS; drop - evict already hashed ranges (do not flood cache of other services).
+    enum class CachePolicy { keep, drop };
 
     class Options {
     public:
         Command         Cmd         {Command::run};
         std::string     InputFile;
+        // File to compare input file with (Command::diff).
+        std::string     DiffFile;
+        // Stop comparing after this number of differing ranges (0 - no limit).
+        size_t          MaxDiffs    {0};
         std::string     OutputFile; 
         size_t          BlockSize   {0};
         size_t          Workers     {0};
         bool            Sorted      {false};
         bool            Mapping     {false};
+        CachePolicy     Cache       {CachePolicy::keep};
         size_t          QueueSize   {0};
+        size_t          BatchSize   {1};
+        size_t          Readers     {1};
+        size_t          MemoryLimit {soft_memmory_limit};
+        std::vector<hash_types> Algorithms {hash_types::crc_16};
+        // Range of input file to be processed (whole file by default).
+        // Results are numbered starting from FirstChunk.
+        uint64_t        Offset      {0};
+        uint64_t        Length      {0};
+        size_t          FirstChunk  {0};
+        // Path to checkpoint file to store progress (no checkpoints if empty).
+        std::string     Checkpoint;
+        bool            Resume      {false};
+        // Follow growing file: wait for new blocks until writer closes it for good (or it does not grow for FollowTimeout).
+        bool            Follow      {false};
+        std::chrono::seconds FollowTimeout {30};
     };
 
     Options ParseCommandLine(int argc, char *argv[]);
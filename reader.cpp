@@ -0,0 +1,232 @@
+#include <string>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include "reader.hpp"
+
+namespace filehasher {
+
+#ifdef _WIN32
+
+// No `pread` on Windows - use own stream for each reader.
+struct file_reader::file_reader_impl {
+    std::ifstream ifile;
+
+    explicit file_reader_impl(const std::string& path) : ifile(path, std::ifstream::binary) {
+        if(!ifile)
+            throw error("failed to open file [" + path + "]");
+    }
+
+    size_t read_at(void *buff, size_t size, uint64_t offset) {
+        ifile.clear();
+        if(!ifile.seekg(offset))
+            throw error("failed to read input file");
+        ifile.read(static_cast<char*>(buff), size);
+        size_t readed = ifile.gcount();
+        if(readed != size && !ifile.eof())
+            throw error("failed to read input file");
+        return readed;
+    }
+
+    uint64_t size() {
+        ifile.clear();
+        if(!ifile.seekg(0, std::ifstream::end))
+            throw error("failed to read input file");
+        return ifile.tellg();
+    }
+
+    void advise(uint64_t, uint64_t, int)
+    {}
+};
+
+#else
+
+struct file_reader::file_reader_impl {
+    int fd;
+
+    explicit file_reader_impl(const std::string& path) : fd(::open(path.c_str(), O_RDONLY)) {
+        if(fd < 0)
+            throw error("failed to open file [" + path + "]");
+#ifdef POSIX_FADV_SEQUENTIAL
+        advise(0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    ~file_reader_impl() {
+        ::close(fd);
+    }
+
+    // `pread` can return less bytes than requested (not only at the end of file) - so read until buffer is full.
+    size_t read_at(void *buff, size_t size, uint64_t offset) {
+        size_t readed = 0;
+        while (readed < size) {
+            auto res = ::pread(fd, static_cast<char*>(buff) + readed, size - readed, offset + readed);
+            if(res < 0 && errno == EINTR)
+                continue;
+            if(res < 0)
+                throw error("failed to read input file");
+            if(res == 0)
+                break;
+            readed += res;
+        }
+        return readed;
+    }
+
+    uint64_t size() {
+        struct stat st;
+        if(::fstat(fd, &st) != 0)
+            throw error("failed to read input file");
+        return st.st_size;
+    }
+
+    // Hints only - errors are ignored.
+    void advise(uint64_t offset, uint64_t size, int advice) {
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(fd, offset, size, advice);
+#endif
+    }
+};
+
+#endif
+
+#if defined(_WIN32) || !defined(POSIX_FADV_SEQUENTIAL)
+static const int advice_willneed = 0;
+static const int advice_dontneed = 0;
+#else
+static const int advice_willneed = POSIX_FADV_WILLNEED;
+static const int advice_dontneed = POSIX_FADV_DONTNEED;
+#endif
+
+file_reader::file_reader(const std::string& path) : pimp(std::make_unique<file_reader_impl>(path))
+{}
+
+file_reader::~file_reader() = default;
+
+size_t file_reader::read_at(void *buff, size_t size, uint64_t offset) {
+    return pimp->read_at(buff, size, offset);
+}
+
+uint64_t file_reader::size() {
+    return pimp->size();
+}
+
+void file_reader::prefetch(uint64_t offset, uint64_t size) {
+    pimp->advise(offset, size, advice_willneed);
+}
+
+void file_reader::drop(uint64_t offset, uint64_t size) {
+    pimp->advise(offset, size, advice_dontneed);
+}
+
+cache_dropper::cache_dropper(const std::string& path, uint64_t offset)
+    : file(path), dropped(offset / cache_drop_alignment * cache_drop_alignment), processed(offset)
+{}
+
+cache_dropper::~cache_dropper() {
+    uint64_t end = (processed + cache_drop_alignment - 1) / cache_drop_alignment * cache_drop_alignment;
+    if(end > dropped)
+        file.drop(dropped, end - dropped);
+}
+
+void cache_dropper::release(uint64_t offset, uint64_t size) {
+    std::lock_guard<std::mutex> lock(guard);
+    if(offset != processed) {
+        ahead.emplace(offset, offset + size);
+        return;
+    }
+
+    processed = offset + size;
+    for (auto it = ahead.begin(); it != ahead.end() && it->first == processed; it = ahead.erase(it))
+        processed = it->second;
+
+    uint64_t end = processed / cache_drop_alignment * cache_drop_alignment;
+    if(end > dropped) {
+        file.drop(dropped, end - dropped);
+        dropped = end;
+    }
+}
+
+#ifdef __linux__
+
+struct file_watcher::file_watcher_impl {
+    int fd;
+
+    explicit file_watcher_impl(const std::string& path) : fd(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+        if(fd < 0)
+            throw error("failed to watch file [" + path + "]");
+        if(::inotify_add_watch(fd, path.c_str(), IN_OPEN | IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+            ::close(fd);
+            throw error("failed to watch file [" + path + "]");
+        }
+    }
+
+    ~file_watcher_impl() {
+        ::close(fd);
+    }
+
+    event wait(std::chrono::milliseconds timeout) {
+        pollfd pfd{fd, POLLIN, 0};
+        auto res = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+        if(res < 0 && errno != EINTR)
+            throw error("failed to watch input file");
+        if(res <= 0)
+            return event::timeout;
+
+        // Read all pending events (descriptor is non blocking).
+        alignas(inotify_event) char buff[4096];
+        bool removed = false;
+        auto last = event::timeout;
+        for (ssize_t len; (len = ::read(fd, buff, sizeof(buff))) > 0;) {
+            for (char *ptr = buff; ptr < buff + len;) {
+                auto ev = reinterpret_cast<const inotify_event*>(ptr);
+                if(ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+                    removed = true;
+                else if(ev->mask & IN_CLOSE_WRITE)
+                    last = event::closed;
+                else if(ev->mask & IN_OPEN)
+                    last = event::opened;
+                else if(ev->mask & IN_MODIFY)
+                    last = event::grown;
+                ptr += sizeof(inotify_event) + ev->len;
+            }
+        }
+        return removed ? event::removed : last;
+    }
+};
+
+#else
+
+struct file_watcher::file_watcher_impl {
+    explicit file_watcher_impl(const std::string&) {
+        throw error("follow mode is not supported on this platform");
+    }
+
+    event wait(std::chrono::milliseconds) {
+        return event::removed;
+    }
+};
+
+#endif
+
+file_watcher::file_watcher(const std::string& path) : pimp(std::make_unique<file_watcher_impl>(path))
+{}
+
+file_watcher::~file_watcher() = default;
+
+file_watcher::event file_watcher::wait(std::chrono::milliseconds timeout) {
+    return pimp->wait(timeout);
+}
+
+}//namespace filehasher
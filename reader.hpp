@@ -0,0 +1,86 @@
+#ifndef FILEHASHER_READER_HPP
+#define FILEHASHER_READER_HPP
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <stdexcept>
+#include <cstdint>
+#include <chrono>
+
+#include "commondefs.hpp"
+
+namespace filehasher {
+
+// Positional file reading (`pread` on POSIX systems, seek + read on others).
+// Each reader owns its own file descriptor, so several readers can read disjoint ranges of the same file in parallel.
+// Sequential access is advised to OS on opening. Page cache hints are ignored where `posix_fadvise` is not supported.
+// Implementation detailes are hided using `pimpl`
+//
+// WARNING: "file_reader" itlef is not thread-safe 
+class file_reader {
+    struct file_reader_impl;
+    const std::unique_ptr<file_reader_impl> pimp;
+
+public:
+    explicit file_reader(const std::string& path);
+    ~file_reader();
+
+    // Reads up to `size` bytes starting from `offset`.
+    // Returns number of bytes readed. It can be less than `size` only at the end of file.
+    size_t read_at(void *buff, size_t size, uint64_t offset);
+
+    // Current size of file (it can grow while reading).
+    uint64_t size();
+
+    // Page cache hints (thread-safe, can be used while other thread reads):
+    // `prefetch` - asks OS to start reading range in background;
+    // `drop` - evicts range (that is not needed anymore) from page cache.
+    void prefetch(uint64_t offset, uint64_t size);
+    void drop(uint64_t offset, uint64_t size);
+};
+
+// Evicts processed ranges of file from page cache (`--cache-policy drop`).
+// Ranges can be released out of order (by several readers or workers) - only contiguous processed prefix is dropped,
+// by pieces aligned to cache_drop_alignment. The rest of it is dropped (rounded up to alignment) in destructor.
+// Implementation is thread-safe.
+class cache_dropper {
+public:
+    // `offset` - where processed range starts.
+    cache_dropper(const std::string& path, uint64_t offset);
+    ~cache_dropper();
+
+    void release(uint64_t offset, uint64_t size);
+
+private:
+    file_reader                     file;
+    std::mutex                      guard;
+    uint64_t                        dropped;
+    uint64_t                        processed;
+    std::map<uint64_t, uint64_t>    ahead;  // released ranges after processed prefix (begin -> end)
+};
+
+// Watches input file changes (`inotify` on Linux). Used to follow growing file.
+// Not supported on other platforms (constructor fails).
+// Implementation detailes are hided using `pimpl`
+class file_watcher {
+    struct file_watcher_impl;
+    const std::unique_ptr<file_watcher_impl> pimp;
+
+public:
+    enum class event { grown, opened, closed, removed, timeout };
+
+    explicit file_watcher(const std::string& path);
+    ~file_watcher();
+
+    // Waits for the next change of file (no longer than `timeout`).
+    // All changes happened since previous call are reported at once - the last one wins (except `removed` one).
+    // `closed` means that writer closed the file - it is only a hint (many writers reopen file for each append).
+    // `removed` means that file was removed or moved - it is not expected to grow anymore.
+    event wait(std::chrono::milliseconds timeout);
+};
+
+}//namespace filehasher
+
+#endif//FILEHASHER_READER_HPP
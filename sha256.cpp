@@ -0,0 +1,85 @@
+#include <cstring>
+#include <algorithm>
+
+#include "sha256.hpp"
+
+namespace filehasher {
+
+static const std::uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline std::uint32_t rotr(std::uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void sha256::reset() {
+    state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    block_size = 0;
+    total_size = 0;
+}
+
+void sha256::process_block(const unsigned char *data) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+        w[i] = (std::uint32_t{data[i * 4]} << 24) | (std::uint32_t{data[i * 4 + 1]} << 16) | (std::uint32_t{data[i * 4 + 2]} << 8) | data[i * 4 + 3];
+    for (int i = 16; i < 64; i++) {
+        std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h] = state;
+    for (int i = 0; i < 64; i++) {
+        std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + round_constants[i] + w[i];
+        std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+// Whole blocks are processed directly from provided data - only the tail is copied to internal buffer.
+void sha256::process_bytes(const void *bytes, size_t size) {
+    auto data = static_cast<const unsigned char*>(bytes);
+    total_size += size;
+
+    if (block_size != 0) {
+        size_t part = std::min(sizeof(block) - block_size, size);
+        std::memcpy(block + block_size, data, part);
+        block_size += part;
+        data += part;
+        size -= part;
+        if (block_size < sizeof(block))
+            return;
+        process_block(block);
+        block_size = 0;
+    }
+
+    for (; size >= sizeof(block); data += sizeof(block), size -= sizeof(block))
+        process_block(data);
+
+    std::memcpy(block, data, size);
+    block_size = size;
+}
+
+void sha256::get_digest(digest_type& digest) {
+    std::uint64_t bits = total_size * 8;
+    unsigned char padding[sizeof(block) + 8] = {0x80};
+    size_t pad_size = (block_size < 56 ? 56 : 120) - block_size;
+    for (int i = 0; i < 8; i++)
+        padding[pad_size + i] = static_cast<unsigned char>(bits >> (56 - i * 8));
+    process_bytes(padding, pad_size + 8);
+    digest = state;
+}
+
+}//namespace filehasher
@@ -0,0 +1,33 @@
+#ifndef FILEHASHER_SHA256_HPP
+#define FILEHASHER_SHA256_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace filehasher {
+
+// SHA-256 (FIPS 180-4) implementation without external dependencies.
+// Boost (1.74) provides only SHA1 - that is not collision resistant. Interface follows `boost::uuids::detail::sha1`.
+class sha256 {
+public:
+    using digest_type = std::array<std::uint32_t, 8>;
+
+    sha256() { reset(); }
+
+    void reset();
+    void process_bytes(const void *bytes, size_t size);
+    void get_digest(digest_type& digest);
+
+private:
+    void process_block(const unsigned char *block);
+
+    std::array<std::uint32_t, 8>    state;
+    unsigned char                   block[64];
+    size_t                          block_size  {0};
+    std::uint64_t                   total_size  {0};
+};
+
+}//namespace filehasher
+
+#endif//FILEHASHER_SHA256_HPP
@@ -4,6 +4,11 @@
 #include <memory>
 #include <future>
 #include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+#include <algorithm>
 
 namespace filehasher {
 
@@ -98,6 +103,116 @@ public:
     }
 };
 
+class memory_budget;
+
+// Amount of memory accounted in memory_budget.
+// Returned back to the budget on destruction, so it can be moved along with data it accounts (chunk buffer, results...).
+class memory_lease {
+    memory_budget   *budget {nullptr};
+    size_t          size    {0};
+
+public:
+    memory_lease() = default;
+    memory_lease(memory_budget& budget, size_t size) : budget(&budget), size(size)
+    {}
+    memory_lease(memory_lease&& rhs) noexcept : budget(std::exchange(rhs.budget, nullptr)), size(std::exchange(rhs.size, 0))
+    {}
+    memory_lease& operator=(memory_lease&& rhs) noexcept {
+        if(&rhs != this) {
+            reset();
+            budget = std::exchange(rhs.budget, nullptr);
+            size = std::exchange(rhs.size, 0);
+        }
+        return *this;
+    }
+    ~memory_lease() {
+        reset();
+    }
+
+    // Accounts more memory without blocking.
+    void grow(size_t more);
+    void reset();
+
+    size_t get_size() const { return size; }
+    explicit operator bool() const { return budget != nullptr; }
+};
+
+// Memory budget shared by all pipeline stages.
+// 'acquire' blocks until requested amount fits the limit. It is used for buffers that can wait for memory (chunks, mapped windows).
+// Request bigger than the limit waits until budget is empty - so it will not wait forever.
+// 'charge' accounts memory without blocking. It is used where waiting can lead to deadlock (results of already read chunks).
+// Tracks peak usage.
+class memory_budget {
+    size_t                  limit;
+    size_t                  used    {0};
+    size_t                  peak    {0};
+    std::mutex              mtx;
+    std::condition_variable condition;
+
+public:
+    explicit memory_budget(size_t limit) : limit(limit)
+    {}
+
+    // Waits for memory until 'cancelled' returns true (checked periodically).
+    // Returns empty lease if cancelled.
+    template<class P>
+    memory_lease acquire(size_t size, P&& cancelled) {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (used != 0 && used + size > limit) {
+            if(cancelled())
+                return memory_lease{};
+            condition.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        take(size);
+        return memory_lease{*this, size};
+    }
+
+    memory_lease charge(size_t size) {
+        std::lock_guard<std::mutex> lock(mtx);
+        take(size);
+        return memory_lease{*this, size};
+    }
+
+    size_t get_limit() const { return limit; }
+    size_t get_peak() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return peak;
+    }
+
+private:
+    friend class memory_lease;
+
+    void take(size_t size) {
+        used += size;
+        peak = std::max(peak, used);
+    }
+
+    void grow(size_t size) {
+        std::lock_guard<std::mutex> lock(mtx);
+        take(size);
+    }
+
+    void release(size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            used -= size;
+        }
+        condition.notify_all();
+    }
+};
+
+inline void memory_lease::grow(size_t more) {
+    budget->grow(more);
+    size += more;
+}
+
+inline void memory_lease::reset() {
+    if(budget != nullptr)
+        budget->release(size);
+    budget = nullptr;
+    size = 0;
+}
+
 struct nan_value {};
 
 template <bool> struct nanness {};